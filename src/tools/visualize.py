@@ -1,15 +1,82 @@
 #!/usr/bin/env python3.6
 import argparse
 import matplotlib.pyplot as plt
+import mmap
 import pygame
 import re
+import struct
 import sys
 import time
 
 DOUBLE = r'(-?\d+\.?\d*)'
 POSITION_PATTERN = re.compile(f'x: {DOUBLE}, y: {DOUBLE},.* paddle: {DOUBLE}')
+LEFT_PADDLE_PATTERN = re.compile(f'left paddle: {DOUBLE}')
 SCORE_PATTERN = re.compile(r'(\d+) bounces.')
 
+# See `src/pong/Trajectory.H`.
+TRAJECTORY_HEADER = struct.Struct('<8sII')
+TRAJECTORY_RECORD = struct.Struct('<QQ5ddiiddiiII')
+# The episode and tick that start every record.
+TRAJECTORY_KEY = struct.Struct('<QQ')
+TRAJECTORY_VERSION = 2
+TRAJECTORY_MAGIC = b'PONGTRJ\x00'
+GOOD_REWARD = 1
+
+def read_text(lines):
+  """Yields ('score', bounces) and ('position', x, y, paddle, left) events.
+
+  `left` is the left paddle of a two-player game, and None otherwise.
+  """
+  for line in lines:
+    m = re.search(SCORE_PATTERN, line)
+    if m:
+      print(line)
+      yield ('score', int(m.group(1)))
+      continue
+    m = re.search(POSITION_PATTERN, line)
+    if m:
+      left = re.search(LEFT_PADDLE_PATTERN, line)
+      yield ('position', float(m.group(1)), float(m.group(2)),
+             float(m.group(3)), float(left.group(1)) if left else None)
+
+def read_trajectory(path):
+  """Same events as `read_text`, from a binary trajectory file.
+
+  Games that share a writer, such as the matches of a tournament, interleave
+  their records, so the records are grouped by episode and ordered by tick.
+  """
+  with open(path, 'rb') as f:
+    data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    magic, version, record_size = TRAJECTORY_HEADER.unpack_from(data)
+    if (magic != TRAJECTORY_MAGIC or version != TRAJECTORY_VERSION
+        or record_size != TRAJECTORY_RECORD.size):
+      sys.exit(f'{path} is not a trajectory file (version {version}).')
+
+    end = TRAJECTORY_HEADER.size + (
+        (len(data) - TRAJECTORY_HEADER.size) // record_size) * record_size
+    # A view of the mapping, so that records are read in place, not copied.
+    with memoryview(data) as view:
+      # Only the episode and tick of each record are read to order them.
+      order = sorted(
+          TRAJECTORY_KEY.unpack_from(view, offset) + (offset,)
+          for offset in range(TRAJECTORY_HEADER.size, end, record_size))
+
+      episode = None
+      bounces = 0
+      for record_episode, _, offset in order:
+        (_, _, x, y, _, _, paddle, _, _, reward,
+         left, _, _, _, agents, _) = TRAJECTORY_RECORD.unpack_from(view, offset)
+        if episode is not None and record_episode != episode:
+          print(f'{bounces} bounces.')
+          yield ('score', bounces)
+          bounces = 0
+        episode = record_episode
+        bounces += reward == GOOD_REWARD
+        yield ('position', x, y, paddle, left if agents > 1 else None)
+    if episode is not None:
+      print(f'{bounces} bounces.')
+      yield ('score', bounces)
+
 def main(args):
   size = (args.width, args.height)
   PADDLE_LENGTH = 0.4 / 2. * args.height
@@ -17,13 +84,16 @@ def main(args):
   games = 0
   bounces = []
 
-  for line in sys.stdin:
-    m = re.search(SCORE_PATTERN, line)
-    if m:
-      print(line)
+  if args.trajectory:
+    events = read_trajectory(args.trajectory)
+  else:
+    events = read_text(sys.stdin)
+
+  for event in events:
+    if event[0] == 'score':
       games += 1
       if args.plot:
-        bounces.append(int(m.group(1)))
+        bounces.append(event[1])
       continue
     elif games < args.game_delay:
       continue
@@ -34,29 +104,37 @@ def main(args):
 
     if done:
       break
-    for event in pygame.event.get():
-      if event.type == pygame.QUIT:
+    for e in pygame.event.get():
+      if e.type == pygame.QUIT:
         done = True
 
-    m = re.search(POSITION_PATTERN, line)
-    if m:
-      x = int((args.width / 2.) * float(m.group(1)) + (args.width / 2.))
-      y = int((args.height / 2.) * float(m.group(2)) + (args.height / 2.))
-      paddle = int(args.height * ((1. + float(m.group(3))) / 2.))
+    _, ball_x, ball_y, paddle_y, left_paddle_y = event
+    x = int((args.width / 2.) * ball_x + (args.width / 2.))
+    y = int((args.height / 2.) * ball_y + (args.height / 2.))
+    paddle = int(args.height * ((1. + paddle_y) / 2.))
 
-      # print(x, y, paddle)
+    # print(x, y, paddle)
 
-      screen.fill((0xff, 0xff, 0xff))
-      pygame.draw.circle(screen, (0x00, 0x00, 0x00), (x, y), 10)
+    screen.fill((0xff, 0xff, 0xff))
+    pygame.draw.circle(screen, (0x00, 0x00, 0x00), (x, y), 10)
+    rect = (
+        args.width-10,
+        paddle - (PADDLE_LENGTH / 2.),
+        10,
+        PADDLE_LENGTH,
+    )
+    pygame.draw.rect(screen, (0x00, 0x00, 0x00), rect)
+    if left_paddle_y is not None:
+      left_paddle = int(args.height * ((1. + left_paddle_y) / 2.))
       rect = (
-          args.width-10,
-          paddle - (PADDLE_LENGTH / 2.),
+          0,
+          left_paddle - (PADDLE_LENGTH / 2.),
           10,
           PADDLE_LENGTH,
       )
       pygame.draw.rect(screen, (0x00, 0x00, 0x00), rect)
-      pygame.display.flip()
-      clock.tick(args.speed)
+    pygame.display.flip()
+    clock.tick(args.speed)
 
   if args.plot:
     plt.scatter(*zip(*enumerate(bounces)), marker='.')
@@ -69,6 +147,6 @@ if __name__ == '__main__':
   parser.add_argument('--speed', type=float, default=60, help='updates per second')
   parser.add_argument('--game-delay', type=float, default=0, help='when to start showing games')
   parser.add_argument('--plot', action='store_true')
+  parser.add_argument('--trajectory', help='binary trajectory file to read instead of stdin')
   args = parser.parse_args()
   main(args)
-